@@ -10,7 +10,8 @@ void displayCommands() {
               << "GET /devices/list\n"
               << "GET /light/[1|2]/[on|off|status]\n"
               << "GET /thermostat/[status|set/<10-30>]\n"
-              << "GET /camera/[status|record/start|record/stop]\n"
+              << "GET /camera/[status|record/start|record/stop|motion]\n"
+              << "GET /rules/[list|clear|add/<rule>]\n"
               << "help - Show commands\n"
               << "exit - Close client\n";
 }
@@ -16,6 +16,22 @@ std::string Light::getStatus() {
     return ss.str();
 }
 
+bool Light::isValidCommand(const std::string& command) const {
+    if (command == "ON" || command == "OFF") {
+        return true;
+    }
+    if (command.find("BRIGHTNESS=") == 0) {
+        try {
+            std::stoi(command.substr(11));
+            return true;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+    return false;
+}
+
 bool Light::executeCommand(const std::string& command) {
     if (command == "ON") {
         state = true;
@@ -38,6 +54,13 @@ bool Light::executeCommand(const std::string& command) {
     return false;
 }
 
+AttributeList Light::getAttributes() const {
+    return {
+        {"state", state ? "ON" : "OFF"},
+        {"brightness", std::to_string(brightness)}
+    };
+}
+
 // Thermostat implementation
 Thermostat::Thermostat(const std::string& ip, const std::string& mac, const Subnet& sub)
     : Device(ip, mac, sub), current_temp(22.0), target_temp(22.0), is_heating(false) {}
@@ -51,12 +74,11 @@ std::string Thermostat::getStatus() {
     return ss.str();
 }
 
-bool Thermostat::executeCommand(const std::string& command) {
+bool Thermostat::isValidCommand(const std::string& command) const {
     if (command.find("SET=") == 0) {
         try {
-            target_temp = std::stof(command.substr(4));
-            is_heating = current_temp < target_temp;
-            return true;
+            float temp = std::stof(command.substr(4));
+            return temp >= MIN_TARGET_TEMP && temp <= MAX_TARGET_TEMP;
         }
         catch (...) {
             return false;
@@ -65,9 +87,29 @@ bool Thermostat::executeCommand(const std::string& command) {
     return false;
 }
 
+bool Thermostat::executeCommand(const std::string& command) {
+    if (!isValidCommand(command)) {
+        return false;
+    }
+    target_temp = std::stof(command.substr(4));
+    is_heating = current_temp < target_temp;
+    return true;
+}
+
+AttributeList Thermostat::getAttributes() const {
+    std::stringstream current, target;
+    current << current_temp;
+    target << target_temp;
+    return {
+        {"current_temp", current.str()},
+        {"target_temp", target.str()},
+        {"heating", is_heating ? "true" : "false"}
+    };
+}
+
 // SecurityCamera implementation
 SecurityCamera::SecurityCamera(const std::string& ip, const std::string& mac, const Subnet& sub)
-    : Device(ip, mac, sub), recording(false), last_motion("Never") {}
+    : Device(ip, mac, sub), recording(false), last_motion("Never"), motion_events(0) {}
 
 std::string SecurityCamera::getStatus() {
     std::stringstream ss;
@@ -77,6 +119,11 @@ std::string SecurityCamera::getStatus() {
     return ss.str();
 }
 
+bool SecurityCamera::isValidCommand(const std::string& command) const {
+    return command == "START_RECORDING" || command == "STOP_RECORDING" ||
+           command.find("MOTION_DETECTED=") == 0;
+}
+
 bool SecurityCamera::executeCommand(const std::string& command) {
     if (command == "START_RECORDING") {
         recording = true;
@@ -87,8 +134,17 @@ bool SecurityCamera::executeCommand(const std::string& command) {
         return true;
     }
     else if (command.find("MOTION_DETECTED=") == 0) {
-        last_motion = command.substr(15);
+        last_motion = command.substr(16);
+        motion_events++;
         return true;
     }
     return false;
+}
+
+AttributeList SecurityCamera::getAttributes() const {
+    return {
+        {"recording", recording ? "true" : "false"},
+        {"last_motion", last_motion},
+        {"motion_events", std::to_string(motion_events)}
+    };
 }
\ No newline at end of file
@@ -3,8 +3,13 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <utility>
 #include "network_config.h"
 
+// Named, string-valued view of a device's state, used by the rule engine
+using AttributeList = std::vector<std::pair<std::string, std::string>>;
+
 class Device {
 protected:
     std::string ip_address;
@@ -18,6 +23,8 @@ public:
     
     virtual std::string getStatus() = 0;
     virtual bool executeCommand(const std::string& command) = 0;
+    virtual bool isValidCommand(const std::string& command) const = 0;
+    virtual AttributeList getAttributes() const = 0;
     
     std::string getIPAddress() const { return ip_address; }
     std::string getMACAddress() const { return mac_address; }
@@ -34,6 +41,8 @@ public:
     Light(const std::string& ip, const std::string& mac, const Subnet& sub);
     std::string getStatus() override;
     bool executeCommand(const std::string& command) override;
+    bool isValidCommand(const std::string& command) const override;
+    AttributeList getAttributes() const override;
 };
 
 class Thermostat : public Device {
@@ -43,20 +52,28 @@ private:
     bool is_heating;
 
 public:
+    static constexpr float MIN_TARGET_TEMP = 10.0f;
+    static constexpr float MAX_TARGET_TEMP = 30.0f;
+
     Thermostat(const std::string& ip, const std::string& mac, const Subnet& sub);
     std::string getStatus() override;
     bool executeCommand(const std::string& command) override;
+    bool isValidCommand(const std::string& command) const override;
+    AttributeList getAttributes() const override;
 };
 
 class SecurityCamera : public Device {
 private:
     bool recording;
     std::string last_motion;
+    int motion_events;
 
 public:
     SecurityCamera(const std::string& ip, const std::string& mac, const Subnet& sub);
     std::string getStatus() override;
     bool executeCommand(const std::string& command) override;
+    bool isValidCommand(const std::string& command) const override;
+    AttributeList getAttributes() const override;
 };
 
 #endif
\ No newline at end of file
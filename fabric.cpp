@@ -0,0 +1,326 @@
+#include "fabric.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX  // Keep windows.h from defining min/max macros
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+namespace {
+    std::string formatIP(unsigned long ip) {
+        std::stringstream ss;
+        ss << ((ip >> 24) & 0xFF) << "." << ((ip >> 16) & 0xFF) << "."
+           << ((ip >> 8) & 0xFF) << "." << (ip & 0xFF);
+        return ss.str();
+    }
+
+    std::string formatMAC(unsigned int id) {
+        char mac[18];
+        std::snprintf(mac, sizeof(mac), "02:00:00:%02X:%02X:%02X",
+                      (id >> 16) & 0xFF, (id >> 8) & 0xFF, id & 0xFF);
+        return mac;
+    }
+
+    void pinToCore(std::thread& t, unsigned int core) {
+#ifdef _WIN32
+        SetThreadAffinityMask(t.native_handle(), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        pthread_setaffinity_np(t.native_handle(), sizeof(cpus), &cpus);
+#else
+        (void)t;
+        (void)core;
+#endif
+    }
+}
+
+// Out-of-class definitions for pre-C++17 builds, where ODR-used static
+// constexpr members are not implicitly inline
+constexpr size_t RouterFabric::QUEUE_CAPACITY;
+constexpr size_t RouterFabric::BATCH_SIZE;
+constexpr int RouterFabric::NO_LINK;
+
+size_t RouterFabric::addRouter(const std::string& name) {
+    auto node = std::make_unique<Node>();
+    node->router = std::make_unique<Router>(name);
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+}
+
+void RouterFabric::attachSubnet(size_t router, const Subnet& subnet, const std::string& gateway_ip) {
+    Node& node = *nodes[router];
+    std::string intf = "lan" + std::to_string(node.subnets.size());
+    node.router->addInterface(Interface(intf, gateway_ip, formatMAC(unsigned(ipToUint32(gateway_ip)))));
+    node.link_for_interface.push_back(NO_LINK);
+    node.router->addRoute(RoutingEntry(subnet.network_addr, "0.0.0.0", subnet.subnet_mask, intf));
+    node.subnets.push_back(subnet);
+}
+
+void RouterFabric::addHost(size_t router, const std::string& ip, const std::string& mac) {
+    nodes[router]->router->updateARP(ip, mac);
+    nodes[router]->hosts.push_back(ipToUint32(ip));
+}
+
+// Joins two routers with a /30 link: `a` takes .1 and `b` takes .2
+void RouterFabric::connect(size_t a, size_t b, const std::string& link_network) {
+    unsigned long network = ipToUint32(link_network);
+    std::string ip_a = formatIP(network + 1);
+    std::string ip_b = formatIP(network + 2);
+    std::string mac_a = formatMAC(unsigned(network + 1));
+    std::string mac_b = formatMAC(unsigned(network + 2));
+    std::string intf = "link" + std::to_string(link_count++);
+
+    queues.push_back(std::make_unique<SpscQueue<Packet>>(QUEUE_CAPACITY));
+    SpscQueue<Packet>* a_to_b = queues.back().get();
+    queues.push_back(std::make_unique<SpscQueue<Packet>>(QUEUE_CAPACITY));
+    SpscQueue<Packet>* b_to_a = queues.back().get();
+
+    Node& node_a = *nodes[a];
+    node_a.router->addInterface(Interface(intf, ip_a, mac_a));
+    node_a.link_for_interface.push_back(int(node_a.links.size()));
+    node_a.router->addRoute(RoutingEntry(link_network, "0.0.0.0", "255.255.255.252", intf));
+    node_a.router->updateARP(ip_b, mac_b);
+    node_a.links.push_back(Link{intf, ip_b, b, a_to_b});
+    node_a.inbound.push_back(b_to_a);
+
+    Node& node_b = *nodes[b];
+    node_b.router->addInterface(Interface(intf, ip_b, mac_b));
+    node_b.link_for_interface.push_back(int(node_b.links.size()));
+    node_b.router->addRoute(RoutingEntry(link_network, "0.0.0.0", "255.255.255.252", intf));
+    node_b.router->updateARP(ip_a, mac_a);
+    node_b.links.push_back(Link{intf, ip_a, a, b_to_a});
+    node_b.inbound.push_back(a_to_b);
+}
+
+// Installs static routes to every remote LAN along BFS shortest paths
+void RouterFabric::computeRoutes() {
+    for (size_t source = 0; source < nodes.size(); ++source) {
+        // first_link[n] = index into source's links of the first hop towards n
+        std::vector<int> first_link(nodes.size(), -1);
+        std::vector<bool> visited(nodes.size(), false);
+        std::queue<size_t> frontier;
+        visited[source] = true;
+        frontier.push(source);
+
+        while (!frontier.empty()) {
+            size_t current = frontier.front();
+            frontier.pop();
+            const auto& links = nodes[current]->links;
+            for (size_t i = 0; i < links.size(); ++i) {
+                size_t peer = links[i].peer;
+                if (visited[peer]) {
+                    continue;
+                }
+                visited[peer] = true;
+                first_link[peer] = current == source ? int(i) : first_link[current];
+                frontier.push(peer);
+            }
+        }
+
+        Node& node = *nodes[source];
+        for (size_t dest = 0; dest < nodes.size(); ++dest) {
+            if (first_link[dest] < 0) {
+                continue;
+            }
+            const Link& hop = node.links[first_link[dest]];
+            for (const auto& subnet : nodes[dest]->subnets) {
+                node.router->addRoute(RoutingEntry(
+                    subnet.network_addr, hop.peer_ip, subnet.subnet_mask, hop.local_interface));
+            }
+        }
+    }
+}
+
+void RouterFabric::runRouter(size_t index, size_t packets, int ttl,
+                             const std::atomic<bool>& start, std::atomic<uint64_t>& finished, uint64_t total) {
+    Node& node = *nodes[index];
+    Router& router = *node.router;
+    RouterStats& stats = node.stats;
+    std::mt19937 rng(unsigned(index) + 1);
+
+    std::vector<Packet> inbox;
+    inbox.reserve(BATCH_SIZE * (node.inbound.size() + 1));
+    // Transit packets are dropped when a ring is full; locally originated
+    // ones wait in `pending` until their ring has room
+    std::vector<std::vector<Packet>> transit(node.links.size());
+    std::vector<std::vector<Packet>> pending(node.links.size());
+    size_t out_interface = 0;
+
+    while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    while (finished.load(std::memory_order_relaxed) < total) {
+        uint64_t done = 0;
+        inbox.clear();
+        for (auto* queue : node.inbound) {
+            queue->popBatch(inbox, BATCH_SIZE);
+        }
+        size_t received = inbox.size();
+
+        // Originate new traffic only once earlier local packets have left
+        bool backlogged = false;
+        for (const auto& queued : pending) {
+            backlogged = backlogged || !queued.empty();
+        }
+        size_t originate = backlogged ? 0 : std::min(BATCH_SIZE, packets - size_t(stats.originated));
+        for (size_t i = 0; i < originate; ++i) {
+            size_t dest = nodes.size() > 1 ? (index + 1 + rng() % (nodes.size() - 1)) % nodes.size() : index;
+            const auto& dest_hosts = nodes[dest]->hosts;
+            inbox.emplace_back(node.hosts[rng() % node.hosts.size()],
+                               dest_hosts[rng() % dest_hosts.size()], ttl);
+        }
+        stats.originated += originate;
+
+        for (size_t i = 0; i < inbox.size(); ++i) {
+            Packet& packet = inbox[i];
+            switch (router.routePacket(packet, out_interface)) {
+                case ForwardResult::Delivered:
+                    stats.delivered++;
+                    done++;
+                    break;
+                case ForwardResult::Forwarded: {
+                    int link = out_interface < node.link_for_interface.size()
+                        ? node.link_for_interface[out_interface] : NO_LINK;
+                    if (link == NO_LINK) {
+                        stats.dropped_no_route++;
+                        done++;
+                    } else {
+                        auto& outbox = i < received ? transit[link] : pending[link];
+                        outbox.push_back(std::move(packet));
+                    }
+                    break;
+                }
+                case ForwardResult::NoRoute:
+                    stats.dropped_no_route++;
+                    done++;
+                    break;
+                case ForwardResult::ArpFailure:
+                    stats.dropped_arp++;
+                    done++;
+                    break;
+                case ForwardResult::TtlExpired:
+                    stats.dropped_ttl++;
+                    done++;
+                    break;
+            }
+        }
+
+        for (size_t i = 0; i < node.links.size(); ++i) {
+            SpscQueue<Packet>* queue = node.links[i].queue;
+
+            // Transit first so the fabric drains before taking new load
+            if (!transit[i].empty()) {
+                size_t pushed = queue->pushBatch(transit[i].data(), transit[i].size());
+                stats.forwarded += pushed;
+                stats.dropped_queue_full += transit[i].size() - pushed;
+                done += transit[i].size() - pushed;
+                transit[i].clear();
+            }
+
+            if (!pending[i].empty()) {
+                size_t pushed = queue->pushBatch(pending[i].data(), pending[i].size());
+                stats.forwarded += pushed;
+                pending[i].erase(pending[i].begin(), pending[i].begin() + pushed);
+            }
+        }
+
+        if (done > 0) {
+            finished.fetch_add(done, std::memory_order_relaxed);
+        }
+        else if (received == 0 && originate == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+FabricResult RouterFabric::run(size_t packets_per_router, int ttl) {
+    for (auto& node : nodes) {
+        node->stats = RouterStats();
+        if (node->hosts.empty()) {
+            std::cerr << "Router " << node->router->getName() << " has no hosts\n";
+            return FabricResult();
+        }
+    }
+
+    std::atomic<bool> start{false};
+    std::atomic<uint64_t> finished{0};
+    uint64_t total = uint64_t(packets_per_router) * nodes.size();
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        threads.emplace_back(&RouterFabric::runRouter, this, i, packets_per_router, ttl,
+                             std::cref(start), std::ref(finished), total);
+        pinToCore(threads.back(), unsigned(i % cores));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    FabricResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    for (const auto& node : nodes) {
+        const RouterStats& s = node->stats;
+        result.totals.originated += s.originated;
+        result.totals.delivered += s.delivered;
+        result.totals.forwarded += s.forwarded;
+        result.totals.dropped_no_route += s.dropped_no_route;
+        result.totals.dropped_arp += s.dropped_arp;
+        result.totals.dropped_ttl += s.dropped_ttl;
+        result.totals.dropped_queue_full += s.dropped_queue_full;
+    }
+    return result;
+}
+
+void runFabricBenchmark(size_t packets_per_router) {
+    size_t max_routers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> sizes;
+    for (size_t count = 1; count < max_routers; count *= 2) {
+        sizes.push_back(count);
+    }
+    sizes.push_back(max_routers);
+
+    std::cout << "Routers  Delivered/s  Hops/s       Delivered  Dropped\n";
+    for (size_t count : sizes) {
+        RouterFabric fabric;
+        for (size_t i = 0; i < count; ++i) {
+            size_t r = fabric.addRouter("r" + std::to_string(i));
+            std::string lan = "10." + std::to_string(i) + ".0.";
+            fabric.attachSubnet(r, Subnet("LAN" + std::to_string(i), lan + "0", "255.255.255.0", 24), lan + "1");
+            for (unsigned int h = 10; h < 14; ++h) {
+                fabric.addHost(r, lan + std::to_string(h), formatMAC(unsigned(i << 8 | h)));
+            }
+        }
+
+        // Ring topology so traffic crosses multiple hops
+        size_t links = count > 2 ? count : count - 1;
+        for (size_t i = 0; i < links; ++i) {
+            fabric.connect(i, (i + 1) % count, formatIP(ipToUint32("172.16.0.0") + 4 * i));
+        }
+        fabric.computeRoutes();
+
+        FabricResult result = fabric.run(packets_per_router);
+        const RouterStats& t = result.totals;
+        uint64_t dropped = t.dropped_no_route + t.dropped_arp + t.dropped_ttl + t.dropped_queue_full;
+        std::printf("%-8zu %-12.0f %-12.0f %-10llu %llu\n", count,
+                    double(t.delivered) / result.seconds,
+                    double(t.delivered + t.forwarded) / result.seconds,
+                    (unsigned long long)t.delivered, (unsigned long long)dropped);
+    }
+}
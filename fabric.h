@@ -0,0 +1,82 @@
+#ifndef FABRIC_H
+#define FABRIC_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include "router.h"
+#include "spsc_queue.h"
+
+struct RouterStats {
+    uint64_t originated = 0;
+    uint64_t delivered = 0;
+    uint64_t forwarded = 0;
+    uint64_t dropped_no_route = 0;
+    uint64_t dropped_arp = 0;
+    uint64_t dropped_ttl = 0;
+    uint64_t dropped_queue_full = 0;
+};
+
+struct FabricResult {
+    double seconds = 0.0;
+    RouterStats totals;
+};
+
+// A set of Router instances joined by point-to-point links. Each router runs
+// on its own thread (pinned to a core where supported) and exchanges packet
+// batches with its neighbours through one SpscQueue per link direction.
+class RouterFabric {
+private:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+    static constexpr size_t BATCH_SIZE = 64;
+    static constexpr int NO_LINK = -1;
+
+    struct Link {
+        std::string local_interface;
+        std::string peer_ip;
+        size_t peer;
+        SpscQueue<Packet>* queue;  // Outbound towards peer
+    };
+
+    struct Node {
+        std::unique_ptr<Router> router;
+        std::vector<Subnet> subnets;
+        std::vector<uint32_t> hosts;
+        std::vector<Link> links;
+        std::vector<int> link_for_interface;  // Router interface index -> links index
+        std::vector<SpscQueue<Packet>*> inbound;
+        RouterStats stats;
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<std::unique_ptr<SpscQueue<Packet>>> queues;
+    size_t link_count = 0;
+
+    void runRouter(size_t index, size_t packets, int ttl,
+                   const std::atomic<bool>& start, std::atomic<uint64_t>& finished, uint64_t total);
+
+public:
+    size_t addRouter(const std::string& name);
+    void attachSubnet(size_t router, const Subnet& subnet, const std::string& gateway_ip);
+    void addHost(size_t router, const std::string& ip, const std::string& mac);
+    void connect(size_t a, size_t b, const std::string& link_network);
+    void computeRoutes();
+
+    // Every router originates `packets_per_router` packets towards hosts on
+    // other routers; returns once each packet is delivered or dropped.
+    // Origination backs off while a router's outbound rings are full, so
+    // drops come from transit traffic only.
+    FabricResult run(size_t packets_per_router, int ttl = 64);
+
+    size_t size() const { return nodes.size(); }
+    Router& getRouter(size_t index) { return *nodes[index]->router; }
+    const RouterStats& getStats(size_t index) const { return nodes[index]->stats; }
+};
+
+// Builds ring fabrics of 1..N routers (N = hardware threads) and prints
+// forwarding throughput for each size
+void runFabricBenchmark(size_t packets_per_router);
+
+#endif
@@ -1,16 +1,20 @@
 #include "server.h"
 #include "client.h"
+#include "fabric.h"
 #include <iostream>
 
 int main() {
     int choice;
-    std::cout << "1. Run Server\n2. Run Client\n> ";
+    std::cout << "1. Run Server\n2. Run Client\n3. Run Router Fabric Benchmark\n> ";
     std::cin >> choice;
     std::cin.ignore(); // Clear newline from input buffer
 
     if (choice == 1) {
         runServer(8080);
     }
+    else if (choice == 3) {
+        runFabricBenchmark(1000000);
+    }
     else {
         runClient("127.0.0.1", 8080);
     }
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
 
 struct Subnet {
     std::string name;
@@ -25,6 +26,55 @@ struct RoutingEntry {
         : destination(dest), next_hop(hop), subnet_mask(mask), interface(intf) {}
 };
 
+struct Interface {
+    std::string name;
+    std::string ip_address;
+    std::string mac_address;
+
+    Interface(const std::string& n, const std::string& ip, const std::string& mac)
+        : name(n), ip_address(ip), mac_address(mac) {}
+};
+
+// Dotted-quad IPv4 to host-order integer; parses without iostreams so it is
+// cheap enough for per-packet paths
+inline uint32_t ipToUint32(const std::string& ip) {
+    uint32_t result = 0;
+    uint32_t octet = 0;
+    for (char c : ip) {
+        if (c == '.') {
+            result = (result << 8) | octet;
+            octet = 0;
+        } else {
+            octet = octet * 10 + uint32_t(c - '0');
+        }
+    }
+    return (result << 8) | octet;
+}
+
+// "aa:bb:cc:dd:ee:ff" to a 48-bit integer
+inline uint64_t macToUint64(const std::string& mac) {
+    uint64_t result = 0;
+    for (char c : mac) {
+        if (c >= '0' && c <= '9') result = (result << 4) | uint64_t(c - '0');
+        else if (c >= 'a' && c <= 'f') result = (result << 4) | uint64_t(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') result = (result << 4) | uint64_t(c - 'A' + 10);
+    }
+    return result;
+}
+
+// Forwarding-plane packet; addresses are host-order integers so hops don't
+// parse or allocate
+struct Packet {
+    uint32_t source_ip;
+    uint32_t dest_ip;
+    uint64_t dest_mac;  // Rewritten at every hop
+    int ttl;
+
+    Packet() : source_ip(0), dest_ip(0), dest_mac(0), ttl(0) {}
+    Packet(uint32_t src, uint32_t dst, int t = 64)
+        : source_ip(src), dest_ip(dst), dest_mac(0), ttl(t) {}
+};
+
 // Predefined subnets for different device types
 const std::vector<Subnet> SUBNETS = {
     Subnet("Lighting",   "192.168.1.0",  "255.255.255.192", 26),
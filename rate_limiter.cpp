@@ -0,0 +1,187 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Largest token count representable in the packed bucket state; one below
+    // the field maximum so a real state can never equal EVICTING
+    constexpr double MAX_BURST = double((uint64_t(1) << 24) - 2) / 1000.0;
+
+    // The wait average halves every this many microseconds without samples
+    constexpr double SHED_HALF_LIFE_US = 250000.0;
+
+    int64_t steadyMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+RateLimiter::RateLimiter() : epoch(std::chrono::steady_clock::now()) {
+    // Defaults sized for a handful of interactive clients per address
+    setLimit(CommandClass::List, 2.0, 5.0);
+    setLimit(CommandClass::Status, 10.0, 20.0);
+    setLimit(CommandClass::Control, 5.0, 10.0);
+}
+
+void RateLimiter::setLimit(CommandClass cls, double tokens_per_second, double burst) {
+    configs[static_cast<size_t>(cls)] = BucketConfig{
+        std::max(0.0, tokens_per_second),
+        std::max(1.0, std::min(burst, MAX_BURST))
+    };
+}
+
+uint64_t RateLimiter::nowMillis() const {
+    // Wraps every ~49 days; never 0, which marks a fresh bucket
+    auto elapsed = std::chrono::steady_clock::now() - epoch;
+    uint64_t ms = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    return ms % TIME_MASK + 1;
+}
+
+uint64_t RateLimiter::refilledTokens(uint64_t state, uint64_t now, const BucketConfig& config) const {
+    const uint64_t burst_milli = uint64_t(config.burst * 1000.0);
+    uint64_t last = state & TIME_MASK;
+    if (last == 0) {
+        return burst_milli;
+    }
+
+    uint64_t tokens = state >> TOKEN_SHIFT;
+    uint64_t elapsed = (now - last) & TIME_MASK;
+    // tokens_per_second is also milli-tokens per millisecond
+    return std::min(burst_milli, tokens + uint64_t(double(elapsed) * config.tokens_per_second));
+}
+
+// Hands a slot to new_key. Parking the state at EVICTING first means no
+// tryAcquire can CAS it while the key changes, and the bumped generation
+// fails any CAS still holding a pre-eviction state.
+bool RateLimiter::evict(Slot& slot, uint64_t old_key, uint64_t new_key) {
+    uint64_t state = slot.state.load(std::memory_order_acquire);
+    if (state == EVICTING || !slot.state.compare_exchange_strong(state, EVICTING, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    uint64_t expected = old_key;
+    bool claimed = slot.key.compare_exchange_strong(expected, new_key, std::memory_order_acq_rel);
+    uint64_t generation = ((state >> GEN_SHIFT) + (claimed ? 1 : 0)) & GEN_MASK;
+    slot.state.store(claimed ? generation << GEN_SHIFT : state, std::memory_order_release);
+    return claimed;
+}
+
+RateLimiter::Slot* RateLimiter::findSlot(uint64_t key, uint64_t now) {
+    uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+    Shard& shard = shards[(hash >> 32) % SHARD_COUNT];
+    size_t index = size_t(hash >> 40) % SLOTS_PER_SHARD;
+
+    Slot* victim = nullptr;
+    uint64_t victim_key = 0;
+    double victim_fill = -1.0;
+
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        Slot& slot = shard.slots[(index + probe) % SLOTS_PER_SHARD];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key) {
+            return &slot;
+        }
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) ||
+                current == key) {
+                return &slot;
+            }
+        }
+
+        // Remember the bucket closest to full as the eviction candidate
+        uint64_t state = slot.state.load(std::memory_order_relaxed);
+        if (state == EVICTING) {
+            continue;
+        }
+        const BucketConfig& config = configs[size_t((current - 1) & 0xFF)];
+        double fill = double(refilledTokens(state, now, config)) / (config.burst * 1000.0);
+        if (fill > victim_fill) {
+            victim = &slot;
+            victim_key = current;
+            victim_fill = fill;
+        }
+    }
+
+    if (victim && evict(*victim, victim_key, key)) {
+        return victim;
+    }
+    return nullptr;
+}
+
+bool RateLimiter::tryAcquire(uint32_t client_addr, CommandClass cls) {
+    const BucketConfig& config = configs[static_cast<size_t>(cls)];
+    uint64_t key = ((uint64_t(client_addr) << 8) | uint64_t(cls)) + 1;
+    const uint64_t now = nowMillis();
+
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        Slot* slot = findSlot(key, now);
+        if (!slot) {
+            break;
+        }
+
+        uint64_t state = slot->state.load(std::memory_order_acquire);
+        // Re-check ownership after reading state: the slot may have been
+        // evicted between findSlot and the load
+        while (state != EVICTING && slot->key.load(std::memory_order_acquire) == key) {
+            uint64_t tokens = refilledTokens(state, now, config);
+            if (tokens < 1000) {
+                return false;
+            }
+
+            uint64_t next = ((tokens - 1000) << TOKEN_SHIFT) | (state & (GEN_MASK << GEN_SHIFT)) | now;
+            if (slot->state.compare_exchange_weak(state, next, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+
+    // Lost eviction races; fail open rather than reject, but make it visible
+    uint64_t count = fail_open_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    if ((count & (count - 1)) == 0) {
+        std::cerr << "[RateLimiter] No bucket available, " << count << " request(s) let through unlimited\n";
+    }
+    return true;
+}
+
+LoadShedder::LoadShedder(int64_t target_us) : target_wait_us(target_us) {}
+
+int64_t LoadShedder::decayedWait(int64_t now_us) const {
+    int64_t avg = avg_wait_us.load(std::memory_order_relaxed);
+    int64_t elapsed = now_us - last_sample_us.load(std::memory_order_relaxed);
+    if (elapsed <= 0) {
+        return avg;
+    }
+    return int64_t(double(avg) * std::exp2(-double(elapsed) / SHED_HALF_LIFE_US));
+}
+
+void LoadShedder::recordWait(int64_t wait_us) {
+    int64_t now = steadyMicros();
+    int64_t decayed = decayedWait(now);
+    int64_t avg = avg_wait_us.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        // Blend into the time-decayed average, not the stale stored one
+        int64_t base = std::min(avg, decayed);
+        next = base + (wait_us - base) / 8;
+    } while (!avg_wait_us.compare_exchange_weak(avg, next, std::memory_order_relaxed));
+    last_sample_us.store(now, std::memory_order_relaxed);
+}
+
+int64_t LoadShedder::averageWait() const {
+    return decayedWait(steadyMicros());
+}
+
+bool LoadShedder::shouldShed(CommandClass cls) const {
+    int64_t avg = averageWait();
+    switch (cls) {
+        case CommandClass::List:
+            return avg > target_wait_us;
+        case CommandClass::Status:
+            return avg > 2 * target_wait_us;
+        default:
+            // State changes are what clients are waiting on; only drop them
+            // when the lock is badly congested
+            return avg > 4 * target_wait_us;
+    }
+}
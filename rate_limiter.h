@@ -0,0 +1,89 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Request classes, each with its own token bucket per client
+enum class CommandClass {
+    List,     // GET /devices/list - walks every device under deviceMutex
+    Status,   // GET /<device>/status
+    Control,  // Anything that changes device state (or fails to parse)
+    Count
+};
+
+struct BucketConfig {
+    double tokens_per_second;
+    double burst;
+};
+
+// Token-bucket limiter keyed by (client IPv4 address, command class).
+// Buckets live in fixed-size open-addressed shards; each bucket is a single
+// atomic word updated with CAS, so the hot path never takes a lock. When a
+// probe sequence is full, the fullest bucket in it is evicted - a full bucket
+// carries no state a fresh one wouldn't.
+class RateLimiter {
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t SLOTS_PER_SHARD = 256;
+    static constexpr size_t MAX_PROBES = 16;
+
+    // state = milli-tokens (24 bits) | generation (8 bits) | last refill ms (32 bits)
+    // A refill time of 0 marks a fresh, full bucket. The generation is bumped on
+    // every eviction so a thread holding a stale slot pointer fails its CAS.
+    static constexpr int TOKEN_SHIFT = 40;
+    static constexpr int GEN_SHIFT = 32;
+    static constexpr uint64_t GEN_MASK = 0xFF;
+    static constexpr uint64_t TIME_MASK = 0xFFFFFFFFULL;
+    static constexpr uint64_t EVICTING = ~uint64_t(0);  // Slot is changing owner
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key{0};    // 0 = empty
+        std::atomic<uint64_t> state{0};
+    };
+
+    struct Shard {
+        std::array<Slot, SLOTS_PER_SHARD> slots;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::array<BucketConfig, static_cast<size_t>(CommandClass::Count)> configs;
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<uint64_t> fail_open_count{0};
+
+    uint64_t nowMillis() const;
+    uint64_t refilledTokens(uint64_t state, uint64_t now, const BucketConfig& config) const;
+    Slot* findSlot(uint64_t key, uint64_t now);
+    bool evict(Slot& slot, uint64_t old_key, uint64_t new_key);
+
+public:
+    RateLimiter();
+    void setLimit(CommandClass cls, double tokens_per_second, double burst);
+    bool tryAcquire(uint32_t client_addr, CommandClass cls);
+
+    // Requests let through because no bucket could be claimed
+    uint64_t failOpenCount() const { return fail_open_count.load(std::memory_order_relaxed); }
+};
+
+// Tracks how long requests wait for the device lock and decides when to shed
+// load. Wait times are smoothed with an EWMA so a single slow acquisition
+// doesn't trip shedding, and the average also decays with wall-clock time so
+// shedding lifts even when shed requests stop producing samples.
+class LoadShedder {
+private:
+    std::atomic<int64_t> avg_wait_us{0};
+    std::atomic<int64_t> last_sample_us{0};
+    int64_t target_wait_us;
+
+    int64_t decayedWait(int64_t now_us) const;
+
+public:
+    explicit LoadShedder(int64_t target_us);
+    void recordWait(int64_t wait_us);
+    bool shouldShed(CommandClass cls) const;
+    int64_t averageWait() const;
+};
+
+#endif
@@ -1,8 +1,9 @@
 #include "router.h"
-#include <sstream>
 #include <iostream>
 
-Router::Router() {
+constexpr size_t Router::NO_INTERFACE;
+
+Router::Router() : name("router0") {
     // Add default routes for each subnet
     for (const auto& subnet : SUBNETS) {
         addRoute(RoutingEntry(
@@ -14,26 +15,7 @@ Router::Router() {
     }
 }
 
-unsigned long Router::ipToUlong(const std::string& ip) {
-    unsigned long result = 0;
-    int shift = 24;  // Start with highest byte
-    std::stringstream ss(ip);
-    std::string octet;
-    
-    while (std::getline(ss, octet, '.')) {
-        result |= (std::stoul(octet) << shift);
-        shift -= 8;
-    }
-    return result;
-}
-
-bool Router::isInSubnet(const std::string& ip, const std::string& network, const std::string& mask) {
-    unsigned long ip_ul = ipToUlong(ip);
-    unsigned long net_ul = ipToUlong(network);
-    unsigned long mask_ul = ipToUlong(mask);
-    
-    return (ip_ul & mask_ul) == (net_ul & mask_ul);
-}
+Router::Router(const std::string& router_name) : name(router_name) {}
 
 bool Router::routePacket(const std::string& source_ip, const std::string& dest_ip) {
     std::string next_hop = findNextHop(dest_ip);
@@ -51,19 +33,107 @@ bool Router::routePacket(const std::string& source_ip, const std::string& dest_i
     return true;
 }
 
+ForwardResult Router::routePacket(Packet& packet, size_t& out_interface) {
+    size_t index = findRoute(packet.dest_ip);
+    if (index == compiled_routes.size()) {
+        return ForwardResult::NoRoute;
+    }
+
+    if (--packet.ttl <= 0) {
+        return ForwardResult::TtlExpired;
+    }
+
+    const CompiledRoute& route = compiled_routes[index];
+    if (route.next_hop == 0) {
+        auto it = neighbors.find(packet.dest_ip);
+        if (it == neighbors.end()) {
+            return ForwardResult::ArpFailure;
+        }
+        packet.dest_mac = it->second;
+    }
+    else if (route.next_hop_resolved) {
+        packet.dest_mac = route.next_hop_mac;
+    }
+    else {
+        return ForwardResult::ArpFailure;
+    }
+
+    if (route.interface_index == NO_INTERFACE) {
+        return ForwardResult::NoRoute;
+    }
+    out_interface = route.interface_index;
+    return route.next_hop == 0 ? ForwardResult::Delivered : ForwardResult::Forwarded;
+}
+
 void Router::addRoute(const RoutingEntry& entry) {
+    size_t interface_index = NO_INTERFACE;
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        if (interfaces[i].name == entry.interface) {
+            interface_index = i;
+            break;
+        }
+    }
+
+    uint32_t next_hop = ipToUint32(entry.next_hop);
+    auto neighbor = neighbors.find(next_hop);
+    uint32_t mask = ipToUint32(entry.subnet_mask);
+
     routing_table.push_back(entry);
+    compiled_routes.push_back(CompiledRoute{
+        ipToUint32(entry.destination) & mask,
+        mask,
+        next_hop,
+        neighbor != neighbors.end() ? neighbor->second : 0,
+        neighbor != neighbors.end(),
+        interface_index
+    });
 }
 
-std::string Router::findNextHop(const std::string& dest_ip) {
-    for (const auto& route : routing_table) {
-        if (isInSubnet(dest_ip, route.destination, route.subnet_mask)) {
-            return route.next_hop;
+void Router::addInterface(const Interface& intf) {
+    interfaces.push_back(intf);
+
+    // Bind any routes that named this interface before it existed
+    for (size_t i = 0; i < routing_table.size(); ++i) {
+        if (compiled_routes[i].interface_index == NO_INTERFACE && routing_table[i].interface == intf.name) {
+            compiled_routes[i].interface_index = interfaces.size() - 1;
+        }
+    }
+}
+
+// Longest-prefix match; returns an index into routing_table, or its size if none
+size_t Router::findRoute(const std::string& dest_ip) {
+    return findRoute(ipToUint32(dest_ip));
+}
+
+size_t Router::findRoute(uint32_t dest_ip) const {
+    size_t best = compiled_routes.size();
+    uint32_t best_mask = 0;
+
+    for (size_t i = 0; i < compiled_routes.size(); ++i) {
+        const CompiledRoute& route = compiled_routes[i];
+        if ((dest_ip & route.mask) == route.network && (best == compiled_routes.size() || route.mask > best_mask)) {
+            best = i;
+            best_mask = route.mask;
         }
     }
-    return "";  // No route found
+    return best;
+}
+
+std::string Router::findNextHop(const std::string& dest_ip) {
+    size_t index = findRoute(dest_ip);
+    return index < routing_table.size() ? routing_table[index].next_hop : "";  // Empty if no route found
 }
 
 void Router::updateARP(const std::string& ip, const std::string& mac) {
     arp_table.addEntry(ip, mac);
-}
\ No newline at end of file
+
+    uint32_t address = ipToUint32(ip);
+    uint64_t hardware = macToUint64(mac);
+    neighbors[address] = hardware;
+    for (auto& route : compiled_routes) {
+        if (route.next_hop == address) {
+            route.next_hop_mac = hardware;
+            route.next_hop_resolved = true;
+        }
+    }
+}
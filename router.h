@@ -3,23 +3,52 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "network_config.h"
 #include "arp.h"
 
+enum class ForwardResult { Delivered, Forwarded, NoRoute, ArpFailure, TtlExpired };
+
 class Router {
 private:
+    // Parsed form of a routing entry, kept parallel to routing_table
+    struct CompiledRoute {
+        uint32_t network;
+        uint32_t mask;
+        uint32_t next_hop;        // 0 for directly connected
+        uint64_t next_hop_mac;
+        bool next_hop_resolved;
+        size_t interface_index;   // NO_INTERFACE until the interface is added
+    };
+
+    std::string name;
+    std::vector<Interface> interfaces;
     std::vector<RoutingEntry> routing_table;
+    std::vector<CompiledRoute> compiled_routes;
     ARPTable arp_table;
+    // Integer mirror of arp_table for routePacket(Packet&). Unsynchronized:
+    // populate it with updateARP before forwarding starts.
+    std::unordered_map<uint32_t, uint64_t> neighbors;
     
-    bool isInSubnet(const std::string& ip, const std::string& network, const std::string& mask);
-    unsigned long ipToUlong(const std::string& ip);
+    size_t findRoute(const std::string& dest_ip);
+    size_t findRoute(uint32_t dest_ip) const;
 
 public:
+    static constexpr size_t NO_INTERFACE = static_cast<size_t>(-1);
+
     Router();
+    explicit Router(const std::string& router_name);
     bool routePacket(const std::string& source_ip, const std::string& dest_ip);
+    // out_interface is an index into getInterfaces(). Reads only integer
+    // state cached at configuration time; takes no locks.
+    ForwardResult routePacket(Packet& packet, size_t& out_interface);
     void addRoute(const RoutingEntry& entry);
+    void addInterface(const Interface& intf);
     std::string findNextHop(const std::string& dest_ip);
     void updateARP(const std::string& ip, const std::string& mac);
+
+    const std::string& getName() const { return name; }
+    const std::vector<Interface>& getInterfaces() const { return interfaces; }
 };
 
-#endif
\ No newline at end of file
+#endif
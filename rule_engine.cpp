@@ -0,0 +1,440 @@
+#include "rule_engine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+    std::string trim(const std::string& s) {
+        size_t start = s.find_first_not_of(" \t");
+        if (start == std::string::npos) {
+            return "";
+        }
+        size_t end = s.find_last_not_of(" \t");
+        return s.substr(start, end - start + 1);
+    }
+
+    std::vector<std::string> split(const std::string& s, char delimiter) {
+        std::vector<std::string> parts;
+        std::stringstream ss(s);
+        std::string part;
+        while (std::getline(ss, part, delimiter)) {
+            parts.push_back(trim(part));
+        }
+        return parts;
+    }
+
+    bool parseNumber(const std::string& s, double& value) {
+        if (s.empty()) {
+            return false;
+        }
+        char* end = nullptr;
+        value = std::strtod(s.c_str(), &end);
+        return *end == '\0';
+    }
+
+    bool parseOp(const std::string& s, ConditionOp& op) {
+        if (s == "==") op = ConditionOp::Equal;
+        else if (s == "!=") op = ConditionOp::NotEqual;
+        else if (s == "<") op = ConditionOp::Less;
+        else if (s == ">") op = ConditionOp::Greater;
+        else if (s == "<=") op = ConditionOp::LessEqual;
+        else if (s == ">=") op = ConditionOp::GreaterEqual;
+        else if (s == "changed") op = ConditionOp::Changed;
+        else return false;
+        return true;
+    }
+
+    template <typename T>
+    bool compare(ConditionOp op, const T& lhs, const T& rhs) {
+        switch (op) {
+            case ConditionOp::Equal:        return lhs == rhs;
+            case ConditionOp::NotEqual:     return lhs != rhs;
+            case ConditionOp::Less:         return lhs < rhs;
+            case ConditionOp::Greater:      return lhs > rhs;
+            case ConditionOp::LessEqual:    return lhs <= rhs;
+            case ConditionOp::GreaterEqual: return lhs >= rhs;
+            default:                        return false;
+        }
+    }
+}
+
+uint64_t RuleEngine::indexKey(uint32_t device_id, uint32_t attribute_index) {
+    return (uint64_t(device_id) << 32) | attribute_index;
+}
+
+uint32_t RuleEngine::trackDevice(Device* device) {
+    auto it = device_ids.find(device);
+    if (it != device_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(tracked_devices.size());
+    tracked_devices.push_back(device);
+    snapshots.emplace_back();
+    device_ids[device] = id;
+    return id;
+}
+
+uint32_t RuleEngine::internAction(Device* device, const std::string& command) {
+    std::string key = device->getIPAddress() + " " + command;
+    auto it = action_ids.find(key);
+    if (it != action_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(actions.size());
+    actions.push_back(RuleAction{device, command});
+    action_epoch.push_back(0);
+    action_ids[key] = id;
+    return id;
+}
+
+const RuleEngine::Snapshot& RuleEngine::snapshot(uint32_t device_id) {
+    Snapshot& snap = snapshots[device_id];
+    if (snap.epoch != current_epoch) {
+        snap.epoch = current_epoch;
+        snap.attributes = tracked_devices[device_id]->getAttributes();
+        snap.numbers.resize(snap.attributes.size());
+        snap.numeric.resize(snap.attributes.size());
+        for (size_t i = 0; i < snap.attributes.size(); ++i) {
+            double number = 0.0;
+            snap.numeric[i] = parseNumber(snap.attributes[i].second, number);
+            snap.numbers[i] = number;
+        }
+    }
+    return snap;
+}
+
+bool RuleEngine::addRule(const std::string& text, const DeviceMap& devices, std::string& error) {
+    size_t arrow = text.find("->");
+    if (arrow == std::string::npos) {
+        error = "Rule must have the form '<conditions> -> <actions>'";
+        return false;
+    }
+
+    Rule rule;
+    rule.text = trim(text);
+    std::vector<Device*> used_devices;
+
+    for (const auto& clause : split(text.substr(0, arrow), '&')) {
+        std::istringstream ss(clause);
+        std::string target, op, value;
+        ss >> target >> op;
+        std::getline(ss, value);
+        value = trim(value);
+
+        size_t colon = target.find(':');
+        if (colon == std::string::npos) {
+            error = "Condition target must be <ip>:<attribute>: " + clause;
+            return false;
+        }
+
+        RuleCondition condition;
+        std::string ip = target.substr(0, colon);
+        std::string attribute = target.substr(colon + 1);
+
+        auto it = devices.find(ip);
+        if (it == devices.end()) {
+            error = "Device not found: " + ip;
+            return false;
+        }
+        Device* device = it->second.get();
+
+        AttributeList attributes = device->getAttributes();
+        size_t index = 0;
+        while (index < attributes.size() && attributes[index].first != attribute) {
+            ++index;
+        }
+        if (index == attributes.size()) {
+            error = "Unknown attribute: " + target;
+            return false;
+        }
+        condition.attribute_index = static_cast<uint32_t>(index);
+
+        if (!parseOp(op, condition.op)) {
+            error = "Unknown operator: " + op;
+            return false;
+        }
+        if (condition.op != ConditionOp::Changed && value.empty()) {
+            error = "Missing value in condition: " + clause;
+            return false;
+        }
+        condition.value = value;
+        condition.is_numeric = parseNumber(value, condition.numeric_value);
+        rule.conditions.push_back(condition);
+        used_devices.push_back(device);
+    }
+
+    std::vector<RuleAction> parsed_actions;
+    for (const auto& clause : split(text.substr(arrow + 2), ',')) {
+        size_t space = clause.find(' ');
+        if (space == std::string::npos) {
+            error = "Action must be <ip> <command>: " + clause;
+            return false;
+        }
+
+        std::string ip = clause.substr(0, space);
+        auto it = devices.find(ip);
+        if (it == devices.end()) {
+            error = "Device not found: " + ip;
+            return false;
+        }
+
+        std::string command = trim(clause.substr(space + 1));
+        if (!it->second->isValidCommand(command)) {
+            error = "Invalid command for " + ip + ": " + command;
+            return false;
+        }
+        parsed_actions.push_back(RuleAction{it->second.get(), command});
+    }
+
+    if (rule.conditions.empty() || parsed_actions.empty()) {
+        error = "Rule needs at least one condition and one action";
+        return false;
+    }
+
+    uint32_t id = static_cast<uint32_t>(rules.size());
+    for (size_t i = 0; i < rule.conditions.size(); ++i) {
+        RuleCondition& condition = rule.conditions[i];
+        condition.device_id = trackDevice(used_devices[i]);
+        Dependents& entry = dependency_index[indexKey(condition.device_id, condition.attribute_index)];
+        switch (condition.op) {
+            case ConditionOp::Equal:
+                if (condition.is_numeric) {
+                    entry.by_number[condition.numeric_value].push_back(id);
+                } else {
+                    entry.by_value[condition.value].push_back(id);
+                }
+                break;
+            case ConditionOp::Less:
+            case ConditionOp::Greater:
+            case ConditionOp::LessEqual:
+            case ConditionOp::GreaterEqual:
+                if (condition.is_numeric) {
+                    entry.thresholds.emplace_back(condition.numeric_value, id);
+                    entry.thresholds_sorted = false;
+                    break;
+                }
+                entry.any.push_back(id);
+                break;
+            default:
+                entry.any.push_back(id);
+                break;
+        }
+    }
+    for (const auto& action : parsed_actions) {
+        rule.actions.push_back(internAction(action.device, action.command));
+    }
+    rules.push_back(std::move(rule));
+    rule_epoch.push_back(0);
+    return true;
+}
+
+void RuleEngine::clearRules() {
+    rules.clear();
+    dependency_index.clear();
+    rule_epoch.clear();
+    tracked_devices.clear();
+    device_ids.clear();
+    snapshots.clear();
+    actions.clear();
+    action_ids.clear();
+    action_epoch.clear();
+}
+
+std::string RuleEngine::describeRules() const {
+    std::stringstream ss;
+    ss << "Rules (" << rules.size() << "):\n";
+    for (size_t i = 0; i < rules.size(); ++i) {
+        ss << "  [" << i << "] " << rules[i].text << "\n";
+    }
+    return ss.str();
+}
+
+bool RuleEngine::evaluate(const Rule& rule, const std::vector<StateChange>& changes) {
+    for (const auto& condition : rule.conditions) {
+        if (condition.op == ConditionOp::Changed) {
+            bool changed = false;
+            for (const auto& change : changes) {
+                if (change.device_id == condition.device_id &&
+                    std::find(change.attributes.begin(), change.attributes.end(),
+                              condition.attribute_index) != change.attributes.end()) {
+                    changed = true;
+                    break;
+                }
+            }
+            if (!changed) {
+                return false;
+            }
+            continue;
+        }
+
+        const Snapshot& snap = snapshot(condition.device_id);
+        size_t index = condition.attribute_index;
+        if (condition.is_numeric) {
+            if (!snap.numeric[index] || !compare(condition.op, snap.numbers[index], condition.numeric_value)) {
+                return false;
+            }
+        }
+        else if (!compare(condition.op, snap.attributes[index].second, condition.value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<RuleEngine::StateChange> RuleEngine::executeBatch(std::vector<uint32_t>& batch,
+                                                              std::vector<std::string>& log) {
+    // Group actions per device so each device is diffed once per batch
+    std::stable_sort(batch.begin(), batch.end(),
+        [this](uint32_t a, uint32_t b) { return actions[a].device < actions[b].device; });
+
+    std::vector<StateChange> changes;
+    for (size_t i = 0; i < batch.size();) {
+        Device* device = actions[batch[i]].device;
+        size_t end = i;
+        while (end < batch.size() && actions[batch[end]].device == device) {
+            ++end;
+        }
+
+        if (!device->isOnline()) {
+            log.push_back(device->getIPAddress() + ": skipped, device is offline");
+            i = end;
+            continue;
+        }
+
+        AttributeList before = device->getAttributes();
+        for (; i < end; ++i) {
+            const RuleAction& action = actions[batch[i]];
+            bool ok = device->executeCommand(action.command);
+            log.push_back(device->getIPAddress() + " " + action.command + (ok ? "" : " (rejected)"));
+        }
+
+        auto tracked = device_ids.find(device);
+        if (tracked == device_ids.end()) {
+            continue;  // No rule reads this device
+        }
+        StateChange change = diff(tracked->second, before, device->getAttributes());
+        if (!change.attributes.empty()) {
+            changes.push_back(std::move(change));
+        }
+    }
+    return changes;
+}
+
+RuleEngine::StateChange RuleEngine::diff(uint32_t device_id, const AttributeList& before,
+                                         const AttributeList& after) {
+    StateChange change{device_id, {}, {}};
+    for (size_t i = 0; i < after.size(); ++i) {
+        if (i >= before.size() || before[i] != after[i]) {
+            change.attributes.push_back(static_cast<uint32_t>(i));
+            change.old_values.push_back(i < before.size() ? before[i].second : "");
+        }
+    }
+    return change;
+}
+
+void RuleEngine::considerRule(uint32_t id, const std::vector<StateChange>& changes, std::vector<uint32_t>& batch) {
+    if (rule_epoch[id] == current_epoch) {
+        return;
+    }
+    rule_epoch[id] = current_epoch;
+    if (!evaluate(rules[id], changes)) {
+        return;
+    }
+    for (uint32_t action : rules[id].actions) {
+        if (action_epoch[action] != current_epoch) {
+            action_epoch[action] = current_epoch;
+            batch.push_back(action);
+        }
+    }
+}
+
+// Queues the rules in `dependents` that change.attributes[position] may affect
+void RuleEngine::collectRules(Dependents& dependents, const StateChange& change, size_t position,
+                              const std::vector<StateChange>& changes, std::vector<uint32_t>& batch) {
+    for (uint32_t id : dependents.any) {
+        considerRule(id, changes, batch);
+    }
+
+    const Snapshot& snap = snapshot(change.device_id);
+    uint32_t attribute = change.attributes[position];
+
+    auto bucket = dependents.by_value.find(snap.attributes[attribute].second);
+    if (bucket != dependents.by_value.end()) {
+        for (uint32_t id : bucket->second) {
+            considerRule(id, changes, batch);
+        }
+    }
+
+    if (dependents.by_number.empty() && dependents.thresholds.empty()) {
+        return;
+    }
+    double old_value = 0.0;
+    bool old_numeric = parseNumber(change.old_values[position], old_value);
+    bool new_numeric = snap.numeric[attribute];
+    double new_value = snap.numbers[attribute];
+
+    if (new_numeric) {
+        auto numbered = dependents.by_number.find(new_value);
+        if (numbered != dependents.by_number.end()) {
+            for (uint32_t id : numbered->second) {
+                considerRule(id, changes, batch);
+            }
+        }
+    }
+
+    if (dependents.thresholds.empty()) {
+        return;
+    }
+    if (!dependents.thresholds_sorted) {
+        std::sort(dependents.thresholds.begin(), dependents.thresholds.end());
+        dependents.thresholds_sorted = true;
+    }
+
+    auto first = dependents.thresholds.begin();
+    auto last = dependents.thresholds.end();
+    if (old_numeric && new_numeric) {
+        // Only thresholds in [low, high] can have flipped
+        double low = std::min(old_value, new_value);
+        double high = std::max(old_value, new_value);
+        first = std::lower_bound(first, last, std::make_pair(low, uint32_t(0)));
+        last = std::upper_bound(first, last, std::make_pair(high, UINT32_MAX));
+    }
+    for (auto it = first; it != last; ++it) {
+        considerRule(it->second, changes, batch);
+    }
+}
+
+std::vector<std::string> RuleEngine::onStateChange(Device* device, const AttributeList& before,
+                                                   const AttributeList& after) {
+    std::vector<std::string> log;
+    auto tracked = device_ids.find(device);
+    if (tracked == device_ids.end()) {
+        return log;
+    }
+
+    std::vector<StateChange> changes = {diff(tracked->second, before, after)};
+    if (changes[0].attributes.empty()) {
+        return log;
+    }
+
+    for (int depth = 0; depth < MAX_CASCADE_DEPTH && !changes.empty(); ++depth) {
+        ++current_epoch;
+        std::vector<uint32_t> batch;
+
+        for (const auto& change : changes) {
+            for (size_t i = 0; i < change.attributes.size(); ++i) {
+                auto it = dependency_index.find(indexKey(change.device_id, change.attributes[i]));
+                if (it != dependency_index.end()) {
+                    collectRules(it->second, change, i, changes, batch);
+                }
+            }
+        }
+
+        changes = executeBatch(batch, log);
+    }
+
+    if (!changes.empty()) {
+        log.push_back("Cascade depth limit reached, remaining rule triggers dropped");
+    }
+    return log;
+}
@@ -0,0 +1,115 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "device.h"
+
+using DeviceMap = std::map<std::string, std::unique_ptr<Device>>;
+
+enum class ConditionOp { Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual, Changed };
+
+struct RuleCondition {
+    uint32_t device_id;        // Index into the engine's tracked devices
+    uint32_t attribute_index;  // Position in the device's AttributeList
+    ConditionOp op;
+    std::string value;
+    double numeric_value;
+    bool is_numeric;
+};
+
+struct RuleAction {
+    Device* device;
+    std::string command;
+};
+
+struct Rule {
+    std::string text;
+    std::vector<RuleCondition> conditions;
+    std::vector<uint32_t> actions;  // Ids into the engine's interned actions
+};
+
+// Server-side automations over the device attributes. Rules are compiled
+// into an index keyed by (device, attribute), so a state change only
+// evaluates the rules that read one of the attributes that changed.
+//
+// Rule syntax:
+//   <ip>:<attribute> <op> [value] [& ...] -> <ip> <command>[, <ip> <command>]
+// where op is one of == != < > <= >= changed, e.g.
+//   192.168.1.97:motion_events changed -> 192.168.1.10 ON, 192.168.1.65 SET=21
+//
+// Not thread-safe; callers hold deviceMutex for every call.
+class RuleEngine {
+private:
+    // Bounds cascades where one rule's actions trigger further rules
+    static constexpr int MAX_CASCADE_DEPTH = 4;
+
+    struct StateChange {
+        uint32_t device_id;
+        std::vector<uint32_t> attributes;
+        std::vector<std::string> old_values;  // Parallel to attributes
+    };
+
+    // Attribute values read once per device per evaluation round
+    struct Snapshot {
+        uint64_t epoch = 0;
+        AttributeList attributes;
+        std::vector<double> numbers;
+        std::vector<bool> numeric;
+    };
+
+    // Rules reading one (device, attribute). Equality conditions are bucketed
+    // by value, so only rules expecting the new value are evaluated. Numeric
+    // range conditions are kept sorted by threshold, so only rules whose
+    // threshold lies between the old and new value are evaluated - a range
+    // condition triggers its rule when it is crossed, not on every change.
+    struct Dependents {
+        std::vector<uint32_t> any;
+        std::unordered_map<std::string, std::vector<uint32_t>> by_value;
+        std::unordered_map<double, std::vector<uint32_t>> by_number;
+        std::vector<std::pair<double, uint32_t>> thresholds;
+        bool thresholds_sorted = true;
+    };
+
+    std::vector<Rule> rules;
+    std::unordered_map<uint64_t, Dependents> dependency_index;
+    std::vector<uint64_t> rule_epoch;  // Dedupes rules within one evaluation round
+
+    std::vector<Device*> tracked_devices;
+    std::unordered_map<Device*, uint32_t> device_ids;
+    std::vector<Snapshot> snapshots;
+
+    // Identical (device, command) actions share an id so a batch runs each once
+    std::vector<RuleAction> actions;
+    std::unordered_map<std::string, uint32_t> action_ids;
+    std::vector<uint64_t> action_epoch;
+
+    uint64_t current_epoch = 0;
+
+    static uint64_t indexKey(uint32_t device_id, uint32_t attribute_index);
+    uint32_t trackDevice(Device* device);
+    uint32_t internAction(Device* device, const std::string& command);
+    const Snapshot& snapshot(uint32_t device_id);
+    bool evaluate(const Rule& rule, const std::vector<StateChange>& changes);
+    void considerRule(uint32_t id, const std::vector<StateChange>& changes, std::vector<uint32_t>& batch);
+    void collectRules(Dependents& dependents, const StateChange& change, size_t position,
+                      const std::vector<StateChange>& changes, std::vector<uint32_t>& batch);
+    std::vector<StateChange> executeBatch(std::vector<uint32_t>& batch, std::vector<std::string>& log);
+    static StateChange diff(uint32_t device_id, const AttributeList& before, const AttributeList& after);
+
+public:
+    bool addRule(const std::string& text, const DeviceMap& devices, std::string& error);
+    void clearRules();
+    size_t ruleCount() const { return rules.size(); }
+    std::string describeRules() const;
+
+    // Evaluates rules affected by `device` going from `before` to `after`,
+    // runs their actions in batches, and returns a log line per executed action
+    std::vector<std::string> onStateChange(Device* device, const AttributeList& before, const AttributeList& after);
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include "device.h"
 #include "router.h"
 #include "network_config.h"
+#include "rate_limiter.h"
+#include "rule_engine.h"
 #include <iostream>
 #include <string>
 #include <thread>
@@ -11,12 +13,43 @@
 #include <mutex>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #pragma comment(lib, "ws2_32.lib")
 
 // Global state and synchronization
 std::mutex deviceMutex;
 Router router;
-std::map<std::string, std::unique_ptr<Device>> devices;
+DeviceMap devices;
+RuleEngine ruleEngine;  // Guarded by deviceMutex
+
+// Admission control
+const int MAX_CLIENTS = 64;          // Concurrent connections served
+const int ACCEPT_BACKLOG = 16;       // Pending connections queued by the OS
+const int64_t TARGET_LOCK_WAIT_US = 2000;
+std::atomic<int> activeClients{0};
+RateLimiter rateLimiter;
+LoadShedder loadShedder(TARGET_LOCK_WAIT_US);
+
+// Acquire deviceMutex, feeding the wait time into the load shedder
+std::unique_lock<std::mutex> lockDevices() {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(deviceMutex);
+    loadShedder.recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return lock;
+}
+
+CommandClass classifyRequest(const std::string& request) {
+    if (request == "GET /devices/list" || request == "GET /rules/list") {
+        return CommandClass::List;
+    }
+    if (request.find("/status") != std::string::npos) {
+        return CommandClass::Status;
+    }
+    return CommandClass::Control;
+}
 
 // Initialize devices
 void initializeDevices() {
@@ -44,7 +77,7 @@ void initializeDevices() {
 
 // Process device command and return response
 std::string processDeviceCommand(const std::string& ip, const std::string& command) {
-    std::lock_guard<std::mutex> lock(deviceMutex);
+    auto lock = lockDevices();
     
     auto it = devices.find(ip);
     if (it == devices.end()) {
@@ -56,14 +89,32 @@ std::string processDeviceCommand(const std::string& ip, const std::string& comma
         return "ERROR: Device is offline";
     }
 
+    // Only pay for the attribute diff when some rule could be listening
+    bool watchRules = ruleEngine.ruleCount() > 0;
+    AttributeList before;
+    if (watchRules) {
+        before = device->getAttributes();
+    }
+
     if (device->executeCommand(command)) {
-        return device->getStatus();
+        std::vector<std::string> ruleLog;
+        if (watchRules) {
+            ruleLog = ruleEngine.onStateChange(device, before, device->getAttributes());
+        }
+        std::string status = device->getStatus();
+
+        // Don't hold deviceMutex while writing the rule log
+        lock.unlock();
+        for (const auto& entry : ruleLog) {
+            std::cout << "[Rules] " << entry << "\n";
+        }
+        return status;
     }
     
     return "ERROR: Invalid command";
 }
 
-void handleClient(SOCKET clientSocket) {
+void handleClient(SOCKET clientSocket, uint32_t clientAddr) {
     char buffer[1024] = {0};
 
     while (true) {
@@ -75,10 +126,25 @@ void handleClient(SOCKET clientSocket) {
 
         std::string request(buffer, bytesReceived);
         request.erase(std::remove(request.begin(), request.end(), '\n'), request.end());
-        std::cout << "[Thread] Received: " << request << "\n";
 
         std::string response;
 
+        // Reject over-limit and shed requests before touching deviceMutex
+        CommandClass commandClass = classifyRequest(request);
+        if (!rateLimiter.tryAcquire(clientAddr, commandClass)) {
+            response = "ERROR: Rate limit exceeded, slow down\n";
+            send(clientSocket, response.c_str(), response.size(), 0);
+            continue;
+        }
+        if (loadShedder.shouldShed(commandClass)) {
+            response = "ERROR: Server overloaded, retry later\n";
+            send(clientSocket, response.c_str(), response.size(), 0);
+            continue;
+        }
+
+        // Only admitted requests are logged; console writes serialize threads
+        std::cout << "[Thread] Received: " << request << "\n";
+
         // Validate request format
         if (request.find("GET /") != 0) {
             response = "ERROR: Invalid request format. Commands must start with 'GET /'\n";
@@ -90,7 +156,7 @@ void handleClient(SOCKET clientSocket) {
         // Parse and handle requests
         if (request == "GET /devices/list") {
             validCommand = true;
-            std::lock_guard<std::mutex> lock(deviceMutex);
+            auto lock = lockDevices();
             response = "Connected devices:\n";
             for (const auto& device : devices) {
                 response += device.second->getStatus() + "\n";
@@ -110,7 +176,7 @@ void handleClient(SOCKET clientSocket) {
                 response = processDeviceCommand(ip, "OFF");
             }
             else if (request.find("/status") != std::string::npos) {
-                std::lock_guard<std::mutex> lock(deviceMutex);
+                auto lock = lockDevices();
                 auto it = devices.find(ip);
                 response = it != devices.end() ? it->second->getStatus() : "ERROR: Light not found";
             }
@@ -135,7 +201,7 @@ void handleClient(SOCKET clientSocket) {
                     // Validate temperature input
                     try {
                         float tempValue = std::stof(temp);
-                        if (tempValue < 10.0 || tempValue > 30.0) {
+                        if (tempValue < Thermostat::MIN_TARGET_TEMP || tempValue > Thermostat::MAX_TARGET_TEMP) {
                             response = "ERROR: Temperature must be between 10°C and 30°C";
                         } else {
                             response = processDeviceCommand(ip, "SET=" + temp);
@@ -146,7 +212,7 @@ void handleClient(SOCKET clientSocket) {
                 }
             }
             else if (request.find("/status") != std::string::npos) {
-                std::lock_guard<std::mutex> lock(deviceMutex);
+                auto lock = lockDevices();
                 auto it = devices.find(ip);
                 response = it != devices.end() ? it->second->getStatus() : "ERROR: Thermostat not found";
             }
@@ -161,7 +227,7 @@ void handleClient(SOCKET clientSocket) {
             std::string ip = "192.168.1.97";
             
             if (request.find("/status") != std::string::npos) {
-                std::lock_guard<std::mutex> lock(deviceMutex);
+                auto lock = lockDevices();
                 auto it = devices.find(ip);
                 response = it != devices.end() ? it->second->getStatus() : "ERROR: Camera not found";
             }
@@ -171,11 +237,49 @@ void handleClient(SOCKET clientSocket) {
             else if (request.find("/record/stop") != std::string::npos) {
                 response = processDeviceCommand(ip, "STOP_RECORDING");
             }
+            else if (request.find("/motion") != std::string::npos) {
+                std::time_t now = std::time(nullptr);
+                char timestamp[16];
+                std::tm local;
+                localtime_s(&local, &now);
+                std::strftime(timestamp, sizeof(timestamp), "%H:%M:%S", &local);
+                response = processDeviceCommand(ip, std::string("MOTION_DETECTED=") + timestamp);
+            }
             else {
                 response = "ERROR: Invalid camera command. Available commands:\n"
                           "  GET /camera/status\n"
                           "  GET /camera/record/start\n"
-                          "  GET /camera/record/stop";
+                          "  GET /camera/record/stop\n"
+                          "  GET /camera/motion";
+            }
+        }
+        else if (request.find("GET /rules/") == 0) {
+            validCommand = true;
+            const std::string addPrefix = "GET /rules/add/";
+
+            if (request == "GET /rules/list") {
+                auto lock = lockDevices();
+                response = ruleEngine.describeRules();
+            }
+            else if (request == "GET /rules/clear") {
+                auto lock = lockDevices();
+                ruleEngine.clearRules();
+                response = "Rules cleared";
+            }
+            else if (request.find(addPrefix) == 0) {
+                auto lock = lockDevices();
+                std::string error;
+                if (ruleEngine.addRule(request.substr(addPrefix.size()), devices, error)) {
+                    response = "Rule added (" + std::to_string(ruleEngine.ruleCount()) + " total)";
+                } else {
+                    response = "ERROR: " + error;
+                }
+            }
+            else {
+                response = "ERROR: Invalid rules command. Available commands:\n"
+                          "  GET /rules/list\n"
+                          "  GET /rules/clear\n"
+                          "  GET /rules/add/<ip>:<attribute> <op> [value] -> <ip> <command>";
             }
         }
 
@@ -187,13 +291,16 @@ void handleClient(SOCKET clientSocket) {
                       "  GET /thermostat/status\n"
                       "  GET /thermostat/set/<temperature>\n"
                       "  GET /camera/status\n"
-                      "  GET /camera/record/[start|stop]";
+                      "  GET /camera/record/[start|stop]\n"
+                      "  GET /camera/motion\n"
+                      "  GET /rules/[list|clear|add/<rule>]";
         }
 
         send(clientSocket, response.c_str(), response.size(), 0);
     }
 
     closesocket(clientSocket);
+    activeClients--;
 }
 
 void runServer(int port) {
@@ -231,7 +338,7 @@ void runServer(int port) {
     }
 
     // Listen for connections
-    if (listen(serverSocket, SOMAXCONN) == SOCKET_ERROR) {
+    if (listen(serverSocket, ACCEPT_BACKLOG) == SOCKET_ERROR) {
         std::cerr << "Listen failed\n";
         closesocket(serverSocket);
         WSACleanup();
@@ -251,8 +358,18 @@ void runServer(int port) {
             continue;
         }
 
+        // At capacity: refuse immediately instead of leaving clients queued
+        if (activeClients.load() >= MAX_CLIENTS) {
+            std::string response = "ERROR: Server busy, too many connections\n";
+            send(clientSocket, response.c_str(), response.size(), 0);
+            closesocket(clientSocket);
+            std::cerr << "Connection refused: client limit reached\n";
+            continue;
+        }
+
+        activeClients++;
         std::cout << "New client connected.\n";
-        std::thread t(handleClient, clientSocket);
+        std::thread t(handleClient, clientSocket, ntohl(client.sin_addr.s_addr));
         t.detach();
     }
 
@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring buffer. Items move in batches:
+// the producer publishes a whole batch with one release store, the consumer
+// drains up to a batch with one acquire load.
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};  // Next slot to read (consumer)
+    alignas(64) std::atomic<size_t> tail{0};  // Next slot to write (producer)
+    alignas(64) size_t cached_head = 0;       // Producer's view of head
+    alignas(64) size_t cached_tail = 0;       // Consumer's view of tail
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Moves items from [first, first + count) into the queue; returns how
+    // many fit. Items that didn't fit are left untouched.
+    size_t pushBatch(T* first, size_t count) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (buffer.size() - (t - cached_head) < count) {
+            cached_head = head.load(std::memory_order_acquire);
+        }
+        size_t free_slots = buffer.size() - (t - cached_head);
+        size_t n = count < free_slots ? count : free_slots;
+        for (size_t i = 0; i < n; ++i) {
+            buffer[(t + i) & mask] = std::move(first[i]);
+        }
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Appends up to max_items to out; returns how many were taken
+    size_t popBatch(std::vector<T>& out, size_t max_items) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (cached_tail == h) {
+            cached_tail = tail.load(std::memory_order_acquire);
+        }
+        size_t available = cached_tail - h;
+        size_t n = available < max_items ? available : max_items;
+        for (size_t i = 0; i < n; ++i) {
+            out.push_back(std::move(buffer[(h + i) & mask]));
+        }
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+};
+
+#endif